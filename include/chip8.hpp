@@ -23,10 +23,15 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  *********************************************************************************/
+#pragma once
 
 #include <stack>
 #include <vector>
+#include <string>
 #include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <stdexcept>
@@ -50,6 +55,8 @@ class Chip8 {
   };
 
   bool redraw_ = false;
+  bool trapping_ = false;
+  bool beep_ = true;
   uint32_t lcg_x = 1103515245;
   uint8_t Random() {
     lcg_x = lcg_x * 1103515245 + 12345;
@@ -57,11 +64,10 @@ class Chip8 {
   }
 
  public:
+  // Clears all of memory (and with it registers, stack, keys and screen) and
+  // reinstalls the fonts. Trapping is switched off and the beep on again.
   void Reset() {
-    program_counter_ = 0x200;
-    stack_pointer_ = delay_timer_ = sound_timer_ = 0;
-
-    static uint8_t fonts[80] = {
+    static uint8_t const fonts[80] = {
         0xF0, 0x90, 0x90,
         0x90, 0xF0,  // 0
         0x20, 0x60, 0x20,
@@ -95,9 +101,21 @@ class Chip8 {
         0xF0, 0x80, 0xF0,
         0x80, 0x80  // F
     };
-    for (std::size_t i = 0; i < 80; ++i) {
-      fonts_[i] = fonts[i];
-    }
+    std::memset(memory_, 0, MEM_SIZE);
+    std::memcpy(fonts_, fonts, sizeof(fonts));
+    program_counter_ = 0x200;
+    redraw_ = trapping_ = false;
+    beep_ = true;
+    lcg_x = 1103515245;
+  }
+
+  // Resets to a snapshot of memory() taken right after LoadProgram, which
+  // avoids going through the file system and the byte-wise font copy.
+  void ResetToImage(uint8_t const *image) {
+    std::memcpy(memory_, image, MEM_SIZE);
+    redraw_ = trapping_ = false;
+    beep_ = true;
+    lcg_x = 1103515245;
   }
 
   Chip8() { Reset(); }
@@ -108,7 +126,7 @@ class Chip8 {
     }
     if (sound_timer_ > 0) {
       --sound_timer_;
-      if (sound_timer_ == 0) std::cout << "BEEP!!" << std::endl;
+      if (sound_timer_ == 0 && beep_) std::cout << "BEEP!!" << std::endl;
     }
   }
 
@@ -185,6 +203,12 @@ class Chip8 {
             program_counter_ = stack_[(--stack_pointer_) & 0xF];
             break;
           default:
+            // With trapping enabled, 0NNN is handed to the caller (e.g. a
+            // debugger breakpoint) and the instruction is left unexecuted.
+            if (trapping_) {
+              program_counter_ -= 2;
+              return 1;
+            }
             std::cerr << "sorry - this emulator does not have an RCA"
                       << std::endl;
             exit(-1);
@@ -399,10 +423,18 @@ class Chip8 {
     return 0;
   }
 
+  void SetTrapping(bool trapping) { trapping_ = trapping; }
+  void SetBeep(bool beep) { beep_ = beep; }
+
   bool CanRedraw() const { return redraw_; }
   void ResetRedrawFlag() { redraw_ = false; }
   uint64_t *graphics() { return graphics_; }
   uint8_t *memory() { return memory_; }
+  uint8_t const *memory() const { return memory_; }
+
+  void SetKey(uint8_t key, bool pressed) { keypress_[key & 0xF] = pressed; }
+  uint8_t V(std::size_t i) const { return V_[i & 0xF]; }
+  uint32_t random_state() const { return lcg_x; }
 
   uint16_t index_register() const { return index_; }
   uint16_t program_counter() const { return program_counter_; }
@@ -0,0 +1,285 @@
+/*********************************************************************************
+ * Copyright (c) 2016, Troels F. Roennow
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Troels F. Rønnow
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "chip8.hpp"
+
+namespace emulators {
+
+// Disassembles a single opcode using the common Cowgod mnemonics.
+inline std::string Disassemble(uint16_t opcode) {
+  uint8_t X = (opcode >> 8) & 0xF;
+  uint8_t Y = (opcode >> 4) & 0xF;
+  uint8_t N = opcode & 0xF;
+  uint8_t NN = opcode & 0xFF;
+  uint16_t NNN = opcode & 0xFFF;
+
+  std::ostringstream out;
+  out << std::hex << std::uppercase;
+  std::string vx = "V" + std::string(1, "0123456789ABCDEF"[X]);
+  std::string vy = "V" + std::string(1, "0123456789ABCDEF"[Y]);
+
+  switch ((opcode >> 12) & 0xF) {
+    case 0x0:
+      if (opcode == 0x00E0)
+        out << "CLS";
+      else if (opcode == 0x00EE)
+        out << "RET";
+      else
+        out << "SYS 0x" << NNN;
+      break;
+    case 0x1: out << "JP 0x" << NNN; break;
+    case 0x2: out << "CALL 0x" << NNN; break;
+    case 0x3: out << "SE " << vx << ", 0x" << int(NN); break;
+    case 0x4: out << "SNE " << vx << ", 0x" << int(NN); break;
+    case 0x5: out << "SE " << vx << ", " << vy; break;
+    case 0x6: out << "LD " << vx << ", 0x" << int(NN); break;
+    case 0x7: out << "ADD " << vx << ", 0x" << int(NN); break;
+    case 0x8: {
+      static char const *ops[16] = {"LD",  "OR", "AND", "XOR", "ADD", "SUB",
+                                    "SHR", "SUBN", 0,   0,     0,     0,
+                                    0,     0,    "SHL", 0};
+      if (ops[N])
+        out << ops[N] << " " << vx << ", " << vy;
+      else
+        out << "DW 0x" << opcode;
+      break;
+    }
+    case 0x9: out << "SNE " << vx << ", " << vy; break;
+    case 0xA: out << "LD I, 0x" << NNN; break;
+    case 0xB: out << "JP V0, 0x" << NNN; break;
+    case 0xC: out << "RND " << vx << ", 0x" << int(NN); break;
+    case 0xD: out << "DRW " << vx << ", " << vy << ", 0x" << int(N); break;
+    case 0xE:
+      if (NN == 0x9E)
+        out << "SKP " << vx;
+      else if (NN == 0xA1)
+        out << "SKNP " << vx;
+      else
+        out << "DW 0x" << opcode;
+      break;
+    case 0xF:
+      switch (NN) {
+        case 0x07: out << "LD " << vx << ", DT"; break;
+        case 0x0A: out << "LD " << vx << ", K"; break;
+        case 0x15: out << "LD DT, " << vx; break;
+        case 0x18: out << "LD ST, " << vx; break;
+        case 0x1E: out << "ADD I, " << vx; break;
+        case 0x29: out << "LD F, " << vx; break;
+        case 0x33: out << "LD B, " << vx; break;
+        case 0x55: out << "LD [I], " << vx; break;
+        case 0x65: out << "LD " << vx << ", [I]"; break;
+        default: out << "DW 0x" << opcode;
+      }
+      break;
+  }
+  return out.str();
+}
+
+// Debugger attached to a Chip8. Breakpoints live in a table beside memory
+// and are checked by the debugger's run loop before each instruction, so the
+// program never observes them. Without breakpoints, watchpoints or register
+// conditions, Continue is the bare core loop with no per-instruction check.
+// Trapping is enabled so that an RCA call (0NNN) stops the run instead of
+// exiting.
+template <std::size_t MEM_SIZE = 0x1000>
+class Debugger {
+ public:
+  enum class StopReason {
+    Step,        // single step completed
+    Breakpoint,  // about to execute a breakpoint address
+    Watchpoint,  // a watched address was accessed
+    Register,    // a register condition was met
+    Trap,        // the program executed an RCA call (0NNN)
+    Limit        // the instruction budget ran out
+  };
+
+  struct Watchpoint {
+    uint16_t address, size;
+    bool read, write;
+  };
+
+  // Stops when V[reg] changes or, if on_change is false, becomes value.
+  struct RegisterCondition {
+    uint8_t reg;
+    bool on_change;
+    uint8_t value;
+  };
+
+ private:
+  Chip8<MEM_SIZE> *machine_;
+  std::vector<uint8_t> breakpoints_;  // one flag per address
+  std::size_t breakpoint_count_ = 0;
+  std::vector<Watchpoint> watchpoints_;
+  std::vector<RegisterCondition> conditions_;
+  uint16_t watch_hit_ = 0;
+  int ticked_pc_ = -1;  // trapped after ticking the timers at this address
+
+  bool IsBreakpoint(uint16_t pc) const { return breakpoints_[pc % MEM_SIZE]; }
+
+  bool Watched(uint16_t begin, uint16_t size, bool write) {
+    for (auto const &w : watchpoints_) {
+      if (!(write ? w.write : w.read)) continue;
+      for (uint16_t i = 0; i < size; ++i) {
+        uint16_t address = (begin + i) & 0xFFF;
+        if (address >= w.address && address < w.address + w.size) {
+          watch_hit_ = address;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Memory accesses through I of the instruction about to be executed.
+  bool HitsWatchpoint(uint16_t opcode) {
+    uint16_t I = machine_->index_register();
+    uint8_t X = (opcode >> 8) & 0xF;
+    if ((opcode >> 12) == 0xD) return Watched(I, opcode & 0xF, false);
+    switch (opcode & 0xF0FF) {
+      case 0xF033: return Watched(I, 3, true);
+      case 0xF055: return Watched(I, X + 1, true);
+      case 0xF065: return Watched(I, X + 1, false);
+    }
+    return false;
+  }
+
+  // The core rewinds the program counter on a trap after the timers were
+  // ticked, so resuming must not tick them again.
+  bool Evaluate() {
+    uint16_t pc = machine_->program_counter();
+    if (ticked_pc_ != pc) machine_->DecrementTimers();
+    ticked_pc_ = -1;
+    if (machine_->EvaluateInstruction() == 0) return true;
+    ticked_pc_ = pc;
+    return false;
+  }
+
+  // Executes one instruction. When resuming, a breakpoint at the program
+  // counter is stepped over rather than reported.
+  StopReason Execute(bool resume) {
+    uint16_t pc = machine_->program_counter();
+    if (!resume && IsBreakpoint(pc)) return StopReason::Breakpoint;
+
+    uint16_t opcode = Peek(pc) << 8 | Peek(pc + 1);
+    bool watched = !watchpoints_.empty() && HitsWatchpoint(opcode);
+    uint8_t V[16];
+    for (std::size_t i = 0; i < 16; ++i) V[i] = machine_->V(i);
+
+    if (!Evaluate()) return StopReason::Trap;
+    if (watched) return StopReason::Watchpoint;
+    for (auto const &c : conditions_) {
+      uint8_t now = machine_->V(c.reg);
+      if (c.on_change ? now != V[c.reg] : (now == c.value && V[c.reg] != now))
+        return StopReason::Register;
+    }
+    return StopReason::Step;
+  }
+
+ public:
+  explicit Debugger(Chip8<MEM_SIZE> *machine)
+      : machine_(machine), breakpoints_(MEM_SIZE, 0) {
+    machine_->SetTrapping(true);
+  }
+
+  ~Debugger() { machine_->SetTrapping(false); }
+
+  void AddBreakpoint(uint16_t address) {
+    if (address >= MEM_SIZE)
+      throw std::runtime_error("breakpoint outside memory");
+    if (!breakpoints_[address]) ++breakpoint_count_;
+    breakpoints_[address] = 1;
+  }
+
+  void RemoveBreakpoint(uint16_t address) {
+    if (address >= MEM_SIZE || !breakpoints_[address]) return;
+    breakpoints_[address] = 0;
+    --breakpoint_count_;
+  }
+
+  void ClearBreakpoints() {
+    std::fill(breakpoints_.begin(), breakpoints_.end(), 0);
+    breakpoint_count_ = 0;
+  }
+
+  void AddWatchpoint(uint16_t address, uint16_t size, bool read, bool write) {
+    watchpoints_.push_back({address, size, read, write});
+  }
+  void ClearWatchpoints() { watchpoints_.clear(); }
+
+  void AddRegisterCondition(uint8_t reg, bool on_change, uint8_t value = 0) {
+    conditions_.push_back({uint8_t(reg & 0xF), on_change, value});
+  }
+  void ClearRegisterConditions() { conditions_.clear(); }
+
+  StopReason Step() { return Execute(true); }
+
+  // Runs until something stops execution or max_instructions have run.
+  StopReason Continue(std::size_t max_instructions) {
+    if (max_instructions == 0) return StopReason::Limit;
+    StopReason reason = Execute(true);
+    if (reason != StopReason::Step) return reason;
+
+    if (!watchpoints_.empty() || !conditions_.empty()) {
+      for (std::size_t n = 1; n < max_instructions; ++n) {
+        reason = Execute(false);
+        if (reason != StopReason::Step) return reason;
+      }
+    } else if (breakpoint_count_ > 0) {
+      for (std::size_t n = 1; n < max_instructions; ++n) {
+        if (IsBreakpoint(machine_->program_counter()))
+          return StopReason::Breakpoint;
+        if (!Evaluate()) return StopReason::Trap;
+      }
+    } else {
+      for (std::size_t n = 1; n < max_instructions; ++n) {
+        machine_->DecrementTimers();
+        if (machine_->EvaluateInstruction() != 0) {
+          ticked_pc_ = machine_->program_counter();
+          return StopReason::Trap;
+        }
+      }
+    }
+    return StopReason::Limit;
+  }
+
+  uint8_t Peek(uint16_t address) const {
+    return machine_->memory()[address & 0xFFF];
+  }
+
+  std::string Disassemble(uint16_t address) const {
+    return emulators::Disassemble(Peek(address) << 8 | Peek(address + 1));
+  }
+
+  uint16_t watch_hit() const { return watch_hit_; }
+  Chip8<MEM_SIZE> &machine() { return *machine_; }
+};
+};
@@ -0,0 +1,272 @@
+/*********************************************************************************
+ * Copyright (c) 2016, Troels F. Roennow
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Troels F. Rønnow
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "chip8.hpp"
+#include "state_hash.hpp"
+
+namespace emulators {
+
+// A Chip8 which keeps a 64-bit hash of its memory (and thereby of its
+// registers, stack and screen, which all live in memory_) up to date. Instead
+// of rehashing 4 KB after every instruction, only the words an instruction can
+// touch are compared and folded into the hash.
+template <std::size_t MEM_SIZE = 0x1000>
+class HashedChip8 {
+  Chip8<MEM_SIZE> machine_;
+  uint64_t hash_ = 0;
+
+  // Words an operation may change, with their values before it. Kept on the
+  // stack of the operation so copies of the machine stay small.
+  struct Touched {
+    std::size_t words[64];
+    uint64_t before[64];
+    std::size_t count = 0;
+
+    void Add(std::size_t word) { words[count++] = word; }
+  };
+
+  // Machine state following the fonts in the memory layout: stack pointer,
+  // stack, V, keypress (up to the screen) and the timers, program counter,
+  // index and opcode (the 8 bytes after the screen).
+  void TouchState(Touched *touched, bool screen) {
+    uint8_t *mem = machine_.memory();
+    std::size_t gfx = (uint8_t *)machine_.graphics() - mem;
+    for (std::size_t w = (16 * 5) / 8; w < gfx / 8; ++w) touched->Add(w);
+    if (screen)
+      for (std::size_t w = gfx / 8; w < gfx / 8 + 32; ++w) touched->Add(w);
+    touched->Add(gfx / 8 + 32);
+  }
+
+  void Snapshot(Touched *touched) {
+    std::size_t *words = touched->words;
+    std::sort(words, words + touched->count);
+    touched->count = std::unique(words, words + touched->count) - words;
+    for (std::size_t i = 0; i < touched->count; ++i)
+      touched->before[i] = LoadWord(machine_.memory(), words[i]);
+  }
+
+  void Update(Touched const &touched) {
+    for (std::size_t i = 0; i < touched.count; ++i) {
+      std::size_t w = touched.words[i];
+      uint64_t after = LoadWord(machine_.memory(), w);
+      if (after != touched.before[i])
+        hash_ ^= MixWord(w, touched.before[i]) ^ MixWord(w, after);
+    }
+  }
+
+ public:
+  // Trapping is enabled so that reaching an RCA call (0NNN) ends a branch
+  // instead of the process, and the beep is silenced since workers must not
+  // share std::cout.
+  explicit HashedChip8(Chip8<MEM_SIZE> const &machine) : machine_(machine) {
+    machine_.SetTrapping(true);
+    machine_.SetBeep(false);
+    Rehash();
+  }
+
+  void Rehash() { hash_ = HashWords(machine_.memory(), MEM_SIZE); }
+
+  // True if the incrementally updated hash equals a full rehash.
+  bool Consistent() const {
+    return hash_ == HashWords(machine_.memory(), MEM_SIZE);
+  }
+
+  // The random number generator lives outside memory_ but still determines
+  // the future of the machine, so it is folded into the hash.
+  uint64_t hash() const {
+    return hash_ ^ MixWord(MEM_SIZE / 8, machine_.random_state());
+  }
+
+  // Presses the keys set in mask and releases the others.
+  void SetKeys(uint16_t mask) {
+    Touched touched;
+    TouchState(&touched, false);
+    Snapshot(&touched);
+    for (uint8_t k = 0; k < 16; ++k) machine_.SetKey(k, (mask >> k) & 1);
+    Update(touched);
+  }
+
+  // Returns true if the machine trapped on an RCA call and did not execute.
+  bool Step() {
+    uint8_t const *mem = machine_.memory();
+    uint16_t pc = machine_.program_counter();
+    uint16_t opcode = (mem[pc] << 8) | mem[pc + 1];
+    uint16_t index = machine_.index_register();
+
+    Touched touched;
+    TouchState(&touched, (opcode >> 12) == 0xD || opcode == 0x00E0);
+    if ((opcode & 0xF0FF) == 0xF033)
+      for (std::size_t i = 0; i < 3; ++i)
+        touched.Add(((index + i) & 0xFFF) / 8);
+    if ((opcode & 0xF0FF) == 0xF055)
+      for (std::size_t i = 0; i < ((opcode >> 8) & 0xF) + 1u; ++i)
+        touched.Add(((index + i) & 0xFFF) / 8);
+    Snapshot(&touched);
+
+    machine_.DecrementTimers();
+    int trapped = machine_.EvaluateInstruction();
+    Update(touched);
+    return trapped != 0;
+  }
+
+  Chip8<MEM_SIZE> const &machine() const { return machine_; }
+};
+
+// Explores the states reachable from a machine by branching over key input.
+// From every state, each of the 17 inputs (no key or one of the 16 keys held)
+// is applied for steps_per_input instructions and released again, so states
+// are stored and compared with all keys up. A branch that traps on an RCA call
+// is counted but not expanded further. Visited states are deduplicated by
+// their 64-bit hash, so two states colliding in the hash are treated as
+// one. The frontier is expanded by one worker per core, each owning a queue
+// and stealing from the others when it runs dry.
+template <std::size_t MEM_SIZE = 0x1000>
+class StateExplorer {
+  struct Node {
+    HashedChip8<MEM_SIZE> machine;
+    std::size_t depth;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_set<uint64_t> hashes;
+  };
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Node> nodes;
+  };
+
+  std::size_t steps_per_input_, max_depth_, max_states_, threads_;
+  std::vector<Shard> visited_;
+  std::vector<Queue> queues_;
+  std::atomic<std::size_t> visited_count_, pending_;
+
+  bool Visit(uint64_t hash) {
+    Shard &shard = visited_[hash % visited_.size()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (!shard.hashes.insert(hash).second) return false;
+    ++visited_count_;
+    return true;
+  }
+
+  void Push(std::size_t id, Node const &node) {
+    ++pending_;
+    std::lock_guard<std::mutex> lock(queues_[id].mutex);
+    queues_[id].nodes.push_back(node);
+  }
+
+  // Owners work depth first from the back, thieves take the oldest (and
+  // typically largest) subtrees from the front.
+  bool Pop(std::size_t id, Node *node) {
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+      Queue &queue = queues_[(id + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.nodes.empty()) continue;
+      if (i == 0) {
+        *node = queue.nodes.back();
+        queue.nodes.pop_back();
+      } else {
+        *node = queue.nodes.front();
+        queue.nodes.pop_front();
+      }
+      return true;
+    }
+    return false;
+  }
+
+  void Expand(std::size_t id, Node const &node) {
+    for (std::size_t input = 0; input < 17; ++input) {
+      Node child = node;
+      bool trapped = false;
+      child.machine.SetKeys(input == 0 ? 0 : 1 << (input - 1));
+      for (std::size_t s = 0; s < steps_per_input_ && !trapped; ++s)
+        trapped = child.machine.Step();
+      child.machine.SetKeys(0);
+      ++child.depth;
+
+      if (!Visit(child.machine.hash()) || trapped) continue;
+      if (child.depth < max_depth_ && visited_count_ < max_states_)
+        Push(id, child);
+    }
+  }
+
+  void Work(std::size_t id, Node *node) {
+    while (pending_ > 0) {
+      if (Pop(id, node)) {
+        Expand(id, *node);
+        --pending_;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+ public:
+  StateExplorer(std::size_t steps_per_input = 20, std::size_t max_depth = 8,
+                std::size_t max_states = 1 << 20,
+                std::size_t threads = std::thread::hardware_concurrency())
+      : steps_per_input_(steps_per_input),
+        max_depth_(max_depth),
+        max_states_(max_states),
+        threads_(threads == 0 ? 1 : threads),
+        visited_(64),
+        queues_(threads_) {}
+
+  // Returns the number of distinct states visited, including the root.
+  std::size_t Explore(Chip8<MEM_SIZE> const &root) {
+    for (auto &shard : visited_) shard.hashes.clear();
+    visited_count_ = 0;
+    pending_ = 0;
+
+    Node start = {HashedChip8<MEM_SIZE>(root), 0};
+    start.machine.SetKeys(0);
+    Visit(start.machine.hash());
+    if (max_depth_ == 0) return visited_count_;
+    Push(0, start);
+
+    std::vector<std::thread> workers;
+    for (std::size_t id = 0; id < threads_; ++id)
+      workers.emplace_back([this, id, &start]() {
+        Node node = start;
+        Work(id, &node);
+      });
+    for (auto &worker : workers) worker.join();
+
+    return visited_count_;
+  }
+
+  std::size_t visited_count() const { return visited_count_; }
+};
+};
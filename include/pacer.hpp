@@ -0,0 +1,107 @@
+/*********************************************************************************
+ * Copyright (c) 2016, Troels F. Roennow
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Troels F. Rønnow
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace emulators {
+
+// Paces emulation against the wall clock rather than against timer
+// callbacks. Each call to Due() returns the number of instructions needed to
+// catch up with the target rate, so late or early callbacks change the batch
+// size instead of the emulation speed. Presentation is limited to the display
+// refresh rate. In turbo mode the rate is uncapped, and only every
+// frame_skip-th refresh is presented.
+class FramePacer {
+  using Clock = std::chrono::steady_clock;
+
+  double instructions_per_second_, refresh_interval_;
+  std::size_t frame_skip_, turbo_batch_;
+  Clock::time_point start_, last_present_;
+  double executed_ = 0;
+  bool turbo_ = false;
+
+  double Seconds(Clock::time_point from, Clock::time_point to) const {
+    return std::chrono::duration<double>(to - from).count();
+  }
+
+ public:
+  FramePacer(double instructions_per_second = 20000, double refresh_rate = 60,
+             std::size_t frame_skip = 4, std::size_t turbo_batch = 1024)
+      : instructions_per_second_(instructions_per_second),
+        refresh_interval_(1. / refresh_rate),
+        frame_skip_(frame_skip),
+        turbo_batch_(turbo_batch),
+        start_(Clock::now()),
+        last_present_(start_) {}
+
+  // Restarts the clock, dropping any backlog.
+  void Rebase() {
+    start_ = Clock::now();
+    executed_ = 0;
+  }
+
+  std::size_t Due() {
+    if (turbo_) return turbo_batch_;
+    double due = Seconds(start_, Clock::now()) * instructions_per_second_ -
+                 executed_;
+
+    // After a long stall (window dragged, debugger attached) catch up at most
+    // a tenth of a second rather than fast-forwarding through the backlog.
+    double max_due = instructions_per_second_ / 10;
+    if (due > max_due) {
+      executed_ += due - max_due;
+      due = max_due;
+    }
+    return due > 0 ? std::size_t(due) : 0;
+  }
+
+  void Executed(std::size_t instructions) { executed_ += instructions; }
+
+  // True at most once per refresh interval (frame_skip intervals in turbo).
+  bool PresentDue() {
+    Clock::time_point now = Clock::now();
+    double interval = refresh_interval_ * (turbo_ ? frame_skip_ : 1);
+    double since = Seconds(last_present_, now);
+    if (since < interval) return false;
+
+    // Advance by whole intervals so that late checks do not add up to drift.
+    if (since < 2 * interval)
+      last_present_ += std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(interval));
+    else
+      last_present_ = now;
+    return true;
+  }
+
+  void SetTurbo(bool turbo) {
+    if (turbo_ && !turbo) Rebase();
+    turbo_ = turbo;
+  }
+  bool turbo() const { return turbo_; }
+};
+};
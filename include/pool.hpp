@@ -0,0 +1,122 @@
+/*********************************************************************************
+ * Copyright (c) 2016, Troels F. Roennow
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Troels F. Rønnow
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "chip8.hpp"
+
+namespace emulators {
+
+// Fixed pool of Chip8 instances for sessions which come and go. All instances
+// live in one arena allocated up front, each on its own cache lines, and are
+// recycled through a free list, so Acquire and Release never touch the heap.
+// An acquired instance is reset to a ROM image with a single memcpy of the
+// whole memory.
+template <std::size_t MEM_SIZE = 0x1000>
+class Chip8Pool {
+ public:
+  using Machine = Chip8<MEM_SIZE>;
+  using Image = std::vector<uint8_t>;
+
+ private:
+  struct alignas(64) Slot {
+    Machine machine;
+  };
+
+  std::unique_ptr<char[]> arena_;
+  Slot *slots_ = nullptr;
+  std::size_t capacity_;
+  std::vector<Machine *> free_;
+  std::mutex mutex_;
+
+ public:
+  explicit Chip8Pool(std::size_t capacity) : capacity_(capacity) {
+    std::size_t space = capacity * sizeof(Slot) + alignof(Slot);
+    arena_.reset(new char[space]);
+    void *begin = arena_.get();
+    slots_ = static_cast<Slot *>(
+        std::align(alignof(Slot), capacity * sizeof(Slot), begin, space));
+
+    free_.reserve(capacity);
+    for (std::size_t i = capacity; i-- > 0;) {
+      new (&slots_[i]) Slot;
+      free_.push_back(&slots_[i].machine);
+    }
+  }
+
+  Chip8Pool(Chip8Pool const &) = delete;
+  Chip8Pool &operator=(Chip8Pool const &) = delete;
+
+  ~Chip8Pool() {
+    for (std::size_t i = 0; i < capacity_; ++i) slots_[i].~Slot();
+  }
+
+  // Loads a ROM once; the returned image can be handed to Acquire any number
+  // of times.
+  static Image LoadImage(std::string const &filename) {
+    Machine machine;
+    machine.LoadProgram(filename);
+    return Image(machine.memory(), machine.memory() + MEM_SIZE);
+  }
+
+  Machine *Acquire(Image const &image) {
+    if (image.size() != MEM_SIZE)
+      throw std::runtime_error("image does not match memory size!");
+    Machine *machine;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (free_.empty()) throw std::runtime_error("emulator pool exhausted!");
+      machine = free_.back();
+      free_.pop_back();
+    }
+    machine->ResetToImage(image.data());
+    return machine;
+  }
+
+  void Release(Machine *machine) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert((void *)machine >= (void *)slots_ &&
+           (void *)machine < (void *)(slots_ + capacity_) &&
+           "machine does not belong to this pool");
+    assert(std::find(free_.begin(), free_.end(), machine) == free_.end() &&
+           "machine released twice");
+    free_.push_back(machine);
+  }
+
+  std::size_t capacity() const { return capacity_; }
+  std::size_t available() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+  }
+};
+};
@@ -0,0 +1,183 @@
+/*********************************************************************************
+ * Copyright (c) 2016, Troels F. Roennow
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Troels F. Rønnow
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "chip8.hpp"
+#include "pool.hpp"
+#include "state_hash.hpp"
+
+namespace emulators {
+
+// Input script shared by all ROMs of a regression run. One command per line:
+//   ipf N          instructions per frame (default 333, i.e. 20000 per s)
+//   mark F         record checksums after frame F
+//   press F K      press key K (hex) at the start of frame F
+//   release F K    release key K at the start of frame F
+// Lines starting with # are ignored.
+struct RegressionScript {
+  std::size_t instructions_per_frame = 333;
+  std::vector<std::size_t> marks;
+  std::multimap<std::size_t, std::pair<uint8_t, bool> > keys;
+
+  static RegressionScript Load(std::string const &filename) {
+    std::ifstream in(filename);
+    if (!in.good()) throw std::runtime_error("could not open " + filename);
+
+    RegressionScript script;
+    std::string cmd;
+    while (in >> cmd) {
+      std::size_t frame;
+      unsigned key;
+      if (cmd[0] == '#') {
+        std::getline(in, cmd);
+      } else if (cmd == "ipf") {
+        in >> script.instructions_per_frame;
+      } else if (cmd == "mark") {
+        in >> frame;
+        if (frame == 0) throw std::runtime_error("marks start at frame 1");
+        script.marks.push_back(frame);
+      } else if (cmd == "press" || cmd == "release") {
+        in >> frame >> std::hex >> key >> std::dec;
+        script.keys.insert({frame, {uint8_t(key), cmd == "press"}});
+      } else {
+        throw std::runtime_error("unknown script command " + cmd);
+      }
+      if (in.fail()) throw std::runtime_error("malformed script " + filename);
+    }
+    std::sort(script.marks.begin(), script.marks.end());
+    return script;
+  }
+};
+
+struct RegressionChecksum {
+  std::size_t frame;
+  uint64_t graphics, memory;
+  bool trapped;  // stopped at an RCA call (0NNN) by this frame
+};
+
+struct RegressionResult {
+  std::vector<RegressionChecksum> checksums;
+  double instructions_per_second = 0;
+  bool trapped = false;
+  std::string error;  // set if the ROM could not be run
+};
+
+// Plays the script on a machine, recording checksums if requested. Returns
+// the number of instructions executed.
+template <std::size_t MEM_SIZE>
+std::size_t PlayRegressionScript(Chip8<MEM_SIZE> *machine,
+                                 RegressionScript const &script,
+                                 RegressionResult *result,
+                                 bool record) {
+  std::size_t last = script.marks.empty() ? 0 : script.marks.back();
+  std::size_t executed = 0;
+  auto mark = script.marks.begin();
+  bool trapped = false;
+
+  for (std::size_t frame = 1; frame <= last; ++frame) {
+    auto keys = script.keys.equal_range(frame);
+    for (auto k = keys.first; k != keys.second; ++k)
+      machine->SetKey(k->second.first, k->second.second);
+
+    for (std::size_t i = 0; i < script.instructions_per_frame && !trapped;
+         ++i) {
+      machine->DecrementTimers();
+      trapped = machine->EvaluateInstruction() != 0;
+      executed += !trapped;
+    }
+
+    for (; record && mark != script.marks.end() && *mark == frame; ++mark)
+      result->checksums.push_back(
+          {frame, HashWords((uint8_t const *)machine->graphics(), 32 * 8),
+           HashWords(machine->memory(), MEM_SIZE), trapped});
+  }
+
+  result->trapped = trapped;
+  return executed;
+}
+
+// Runs a ROM image headless through the script on a machine from the pool,
+// recording the checksums. The beep is silenced to keep the report clean.
+template <std::size_t MEM_SIZE>
+RegressionResult RunRegression(Chip8Pool<MEM_SIZE> &pool,
+                               typename Chip8Pool<MEM_SIZE>::Image const &image,
+                               RegressionScript const &script) {
+  RegressionResult result;
+  Chip8<MEM_SIZE> *machine = pool.Acquire(image);
+  machine->SetTrapping(true);
+  machine->SetBeep(false);
+  PlayRegressionScript(machine, script, &result, true);
+  pool.Release(machine);
+  return result;
+}
+
+// Instructions per second of a ROM image through the script: the best of
+// samples timed runs, each replaying the script for at least sample_seconds
+// so that short scripts do not measure noise. Zero for ROMs which trap.
+// Results are only comparable when measured under the same load, so callers
+// should measure all ROMs the same way, e.g. one after the other.
+template <std::size_t MEM_SIZE>
+double MeasureThroughput(Chip8Pool<MEM_SIZE> &pool,
+                         typename Chip8Pool<MEM_SIZE>::Image const &image,
+                         RegressionScript const &script,
+                         std::size_t samples = 5,
+                         double sample_seconds = 0.05) {
+  RegressionResult result;
+  Chip8<MEM_SIZE> *machine = pool.Acquire(image);
+  double best = 0;
+
+  for (std::size_t n = 0; n < samples; ++n) {
+    std::size_t total = 0;
+    std::chrono::duration<double> elapsed(0);
+    auto start = std::chrono::steady_clock::now();
+    while (elapsed.count() < sample_seconds) {
+      machine->ResetToImage(image.data());
+      machine->SetTrapping(true);
+      machine->SetBeep(false);
+      std::size_t executed =
+          PlayRegressionScript(machine, script, &result, false);
+      if (result.trapped || executed == 0) {
+        pool.Release(machine);
+        return 0;
+      }
+      total += executed;
+      elapsed = std::chrono::steady_clock::now() - start;
+    }
+    best = std::max(best, total / elapsed.count());
+  }
+
+  pool.Release(machine);
+  return best;
+}
+};
@@ -0,0 +1,59 @@
+/*********************************************************************************
+ * Copyright (c) 2016, Troels F. Roennow
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Troels F. Rønnow
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace emulators {
+
+// Position keyed XOR hash over 64-bit words. Since words are combined by XOR,
+// a single changed word can be folded in without rehashing the rest:
+//   hash ^= MixWord(i, old_word) ^ MixWord(i, new_word)
+inline uint64_t Finalize(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+inline uint64_t MixWord(std::size_t position, uint64_t word) {
+  return Finalize(word ^ Finalize((position + 1) * 0x9E3779B97F4A7C15ull));
+}
+
+inline uint64_t LoadWord(uint8_t const *data, std::size_t position) {
+  uint64_t word;
+  std::memcpy(&word, data + 8 * position, 8);
+  return word;
+}
+
+// Hashes size bytes of data. size is expected to be a multiple of 8.
+inline uint64_t HashWords(uint8_t const *data, std::size_t size) {
+  uint64_t hash = 0;
+  for (std::size_t i = 0; i < size / 8; ++i)
+    hash ^= MixWord(i, LoadWord(data, i));
+  return hash;
+}
+};
@@ -0,0 +1,144 @@
+/*********************************************************************************
+ * Copyright (c) 2016, Troels F. Roennow
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Troels F. Rønnow
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+#include "chip8.hpp"
+#include "debugger.hpp"
+using Emulator = emulators::Chip8<>;
+using Debugger = emulators::Debugger<>;
+
+void print_registers(Emulator const &emulator) {
+  std::cout << std::hex << std::uppercase;
+  for (std::size_t i = 0; i < 16; ++i)
+    std::cout << "V" << i << "=" << std::setw(2) << std::setfill('0')
+              << int(emulator.V(i)) << (i % 8 == 7 ? "\n" : " ");
+  std::cout << "PC=" << std::setw(3) << emulator.program_counter()
+            << " I=" << std::setw(3) << emulator.index_register()
+            << " SP=" << int(emulator.stack_pointer())
+            << " DT=" << int(emulator.delay_timer()) << std::endl;
+  std::cout << std::dec << std::setfill(' ');
+}
+
+void print_listing(Debugger const &debugger, uint16_t address, int count) {
+  for (int i = 0; i < count; ++i, address += 2)
+    std::cout << std::hex << std::uppercase << std::setw(4) << address
+              << std::dec << "  " << debugger.Disassemble(address)
+              << std::endl;
+}
+
+char const *describe(Debugger::StopReason reason) {
+  switch (reason) {
+    case Debugger::StopReason::Step: return "stepped";
+    case Debugger::StopReason::Breakpoint: return "breakpoint";
+    case Debugger::StopReason::Watchpoint: return "watchpoint";
+    case Debugger::StopReason::Register: return "register condition";
+    case Debugger::StopReason::Trap: return "RCA call";
+    case Debugger::StopReason::Limit: return "instruction limit";
+  }
+  return "";
+}
+
+int main(int argc, char **argv) {
+  /**  Creating emulator and loading rom **/
+  if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " [rom]" << std::endl;
+    return -1;
+  }
+
+  Emulator emulator;
+  if (int err = emulator.LoadProgram(argv[1]) != 0) {
+    std::cerr << "loading " << argv[1] << " returned error code " << err
+              << std::endl;
+    return -1;
+  }
+
+  /** Command loop **/
+  Debugger debugger(&emulator);
+  std::string line;
+  while (std::cout << "(chip8) " << std::flush, std::getline(std::cin, line)) {
+    // Numeric (hex) arguments come first, a word such as r or w ends them.
+    std::istringstream in(line);
+    std::string cmd, token, mode;
+    std::vector<unsigned long> args;
+    in >> cmd;
+    while (mode.empty() && in >> token) {
+      char *end;
+      unsigned long value = std::strtoul(token.c_str(), &end, 16);
+      if (*end == '\0')
+        args.push_back(value);
+      else
+        mode = token;
+    }
+    unsigned long a = args.size() > 0 ? args[0] : 0;
+    unsigned long b = args.size() > 1 ? args[1] : 0;
+
+    if ((cmd == "b" || cmd == "d" || cmd == "w" || cmd == "l") &&
+        a >= 0x1000) {
+      std::cout << "address outside memory" << std::endl;
+      continue;
+    }
+
+    try {
+      if (cmd == "b") {
+        debugger.AddBreakpoint(a);
+      } else if (cmd == "d") {
+        debugger.RemoveBreakpoint(a);
+      } else if (cmd == "w") {
+        debugger.AddWatchpoint(a, b ? b : 1, mode != "w", mode != "r");
+      } else if (cmd == "r") {
+        debugger.AddRegisterCondition(a, true);
+      } else if (cmd == "s" || cmd == "c") {
+        Debugger::StopReason reason =
+            cmd == "s" ? debugger.Step() : debugger.Continue(a ? a : ~0u);
+        std::cout << describe(reason);
+        if (reason == Debugger::StopReason::Watchpoint)
+          std::cout << " at 0x" << std::hex << debugger.watch_hit()
+                    << std::dec;
+        std::cout << std::endl;
+        print_listing(debugger, emulator.program_counter(), 1);
+      } else if (cmd == "p") {
+        print_registers(emulator);
+      } else if (cmd == "l") {
+        print_listing(debugger, a ? a : emulator.program_counter(), b ? b : 8);
+      } else if (cmd == "q") {
+        break;
+      } else if (!cmd.empty()) {
+        std::cout << "b ADDR | d ADDR | w ADDR [SIZE] [r|w] | r REG | s | "
+                     "c [N] | p | l [ADDR] [N] | q"
+                  << std::endl;
+      }
+    } catch (std::runtime_error const &e) {
+      std::cout << e.what() << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*********************************************************************************
+ * Copyright (c) 2016, Troels F. Roennow
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Troels F. Rønnow
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "chip8.hpp"
+#include "explorer.hpp"
+using Emulator = emulators::Chip8<>;
+
+// Self-test of the incremental hash: walks the rom with changing key input
+// and compares against a full rehash after every step.
+bool check_hash(Emulator const &emulator, std::size_t steps = 2000) {
+  emulators::HashedChip8<> walker(emulator);
+  for (std::size_t i = 0; i < steps; ++i) {
+    if (i % 50 == 0) walker.SetKeys(1 << ((i / 50) % 17) >> 1);
+    if (!walker.Consistent()) return false;
+    bool trapped = walker.Step();
+    if (!walker.Consistent()) return false;
+    if (trapped) break;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argc > 4) {
+    std::cerr << "usage: " << argv[0] << " [rom] [depth] [steps per input]"
+              << std::endl;
+    return -1;
+  }
+
+  Emulator emulator;
+  if (int err = emulator.LoadProgram(argv[1]) != 0) {
+    std::cerr << "loading " << argv[1] << " returned error code " << err
+              << std::endl;
+    return -1;
+  }
+
+  if (!check_hash(emulator)) {
+    std::cerr << "incremental state hash diverged from full rehash"
+              << std::endl;
+    return -1;
+  }
+
+  std::size_t depth = argc > 2 ? std::stoul(argv[2]) : 4;
+  std::size_t steps = argc > 3 ? std::stoul(argv[3]) : 20;
+  emulators::StateExplorer<> explorer(steps, depth);
+
+  auto start = std::chrono::steady_clock::now();
+  std::size_t states = explorer.Explore(emulator);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::cout << "Explored " << states << " distinct states in "
+            << elapsed.count() << " s" << std::endl;
+
+  return 0;
+}
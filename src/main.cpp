@@ -26,52 +26,80 @@
 #include <iostream>
 #include "chip8.hpp"
 #include "canvas.hpp"
+#include "pacer.hpp"
 using Emulator = emulators::Chip8<>;
 
 emulators::Canvas *cv;
-Emulator *emulator;
+Emulator emulator;
 int frame = 0;
-#define TARGET_SCREEN_FPS 1000
+#define INSTRUCTIONS_PER_SECOND 20000
+#define DISPLAY_REFRESH_RATE 60
+#define TURBO_KEY '\t'
+emulators::FramePacer pacer(INSTRUCTIONS_PER_SECOND, DISPLAY_REFRESH_RATE);
 
 void render() { cv->Render(); }
-void main_loop(int val = 0) {
-  //  for(std::size_t i=0; i<8; ++i)
-  for (std::size_t i = 0; i < 20; ++i) {
-    emulator->DecrementTimers();
-    emulator->EvaluateInstruction();
+void present() {
+  cv->Lock();
+  for (std::size_t i = 0; i < 32; ++i) {
+    uint64_t p = emulator.graphics()[i];
+    uint64_t mask = 1ull << 63;
+    for (int j = 0; j < 64; ++j) {
+      if (p & mask)
+        cv->SetPixel(i, j, 255);
+      else
+        cv->SetPixel(i, j, 0);
+
+      mask >>= 1;
+    }
   }
+  cv->Unlock();
+  render();
+  emulator.ResetRedrawFlag();
+}
 
-  if (emulator->CanRedraw()) {
-    cv->Lock();
-    for (std::size_t i = 0; i < 32; ++i) {
-      uint64_t p = emulator->graphics()[i];
-      uint64_t mask = 1ull << 63;
-      for (int j = 0; j < 64; ++j) {
-        if (p & mask)
-          cv->SetPixel(i, j, 255);
-        else
-          cv->SetPixel(i, j, 0);
+void run(std::size_t instructions) {
+  for (std::size_t i = 0; i < instructions; ++i) {
+    emulator.DecrementTimers();
+    emulator.EvaluateInstruction();
+  }
+  pacer.Executed(instructions);
+}
 
-        mask >>= 1;
-      }
-    }
-    cv->Unlock();
-    render();
-    emulator->ResetRedrawFlag();
+void main_loop(int val = 0) {
+  if (pacer.turbo()) {
+    // Spend the whole frame on emulation and come back to GLUT only to
+    // present and handle input.
+    do run(pacer.Due());
+    while (!pacer.PresentDue());
+    if (emulator.CanRedraw()) present();
+    glutTimerFunc(0, main_loop, frame);
+    return;
   }
 
-  glutTimerFunc(1000 / TARGET_SCREEN_FPS, main_loop, frame);
+  run(pacer.Due());
+
+  // Screen updates between two refreshes are coalesced into one.
+  if (emulator.CanRedraw() && pacer.PresentDue()) present();
+
+  glutTimerFunc(1, main_loop, frame);
+}
+
+void key_down(unsigned char key, int x, int y) {
+  if (key == TURBO_KEY) pacer.SetTurbo(true);
+}
+
+void key_up(unsigned char key, int x, int y) {
+  if (key == TURBO_KEY) pacer.SetTurbo(false);
 }
 
 int main(int argc, char **argv) {
   /**  Creating emulator and loading rom **/
-  emulator = new Emulator;
   if (argc != 2) {
     std::cerr << "usage: " << argv[0] << " [filename]" << std::endl;
     return -1;
   }
 
-  if (int err = emulator->LoadProgram(argv[1]) != 0) {
+  if (int err = emulator.LoadProgram(argv[1]) != 0) {
     std::cerr << "loading " << argv[1] << " returned error code " << err
               << std::endl;
     return -1;
@@ -81,7 +109,11 @@ int main(int argc, char **argv) {
   cv = new emulators::Canvas;
   cv->Initialize();
   glutDisplayFunc(render);
-  glutTimerFunc(1000 / TARGET_SCREEN_FPS, main_loop, frame);
+  glutIgnoreKeyRepeat(1);
+  glutKeyboardFunc(key_down);
+  glutKeyboardUpFunc(key_up);
+  pacer.Rebase();
+  glutTimerFunc(1, main_loop, frame);
   glutMainLoop();
   delete cv;
 
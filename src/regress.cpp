@@ -0,0 +1,201 @@
+/*********************************************************************************
+ * Copyright (c) 2016, Troels F. Roennow
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2016 Troels F. Rønnow
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *********************************************************************************/
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "chip8.hpp"
+#include "pool.hpp"
+#include "regression.hpp"
+using Pool = emulators::Chip8Pool<>;
+using Result = emulators::RegressionResult;
+
+// A ROM is flagged as slow when it runs this much below its baseline, on
+// the first run and on every retry.
+#define THROUGHPUT_TOLERANCE 0.25
+#define THROUGHPUT_RETRIES 2
+
+std::vector<std::string> list_roms(std::string const &directory) {
+  std::vector<std::string> roms;
+  DIR *dir = opendir(directory.c_str());
+  if (dir == nullptr) throw std::runtime_error("could not open " + directory);
+  while (dirent *entry = readdir(dir)) {
+    struct stat info;
+    std::string path = directory + "/" + entry->d_name;
+    if (entry->d_name[0] != '.' && stat(path.c_str(), &info) == 0 &&
+        S_ISREG(info.st_mode))
+      roms.push_back(entry->d_name);
+  }
+  closedir(dir);
+  std::sort(roms.begin(), roms.end());
+  return roms;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 5 && argc != 6) {
+    std::cerr << "usage: " << argv[0]
+              << " [rom dir] [script] [golden] [baseline] [update]"
+              << std::endl;
+    return -1;
+  }
+  std::string directory = argv[1];
+  bool update = argc == 6 && std::string(argv[5]) == "update";
+
+  std::vector<std::string> roms = list_roms(directory);
+  emulators::RegressionScript script =
+      emulators::RegressionScript::Load(argv[2]);
+
+  /** Running all roms in parallel **/
+  std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  Pool pool(threads);
+  std::vector<Pool::Image> images(roms.size());
+  std::vector<Result> results(roms.size());
+  std::atomic<std::size_t> next(0);
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < threads; ++t)
+    workers.emplace_back([&]() {
+      for (std::size_t i; (i = next++) < roms.size();) {
+        try {
+          images[i] = Pool::LoadImage(directory + "/" + roms[i]);
+          results[i] = emulators::RunRegression(pool, images[i], script);
+        } catch (std::runtime_error const &e) {
+          results[i].error = e.what();
+        }
+      }
+    });
+  for (auto &worker : workers) worker.join();
+
+  /** Measuring throughput one rom at a time, so that every measurement, when
+   * recording the baseline and when checking it, sees the same load **/
+  for (std::size_t i = 0; i < roms.size(); ++i)
+    if (results[i].error.empty() && !results[i].trapped)
+      results[i].instructions_per_second =
+          emulators::MeasureThroughput(pool, images[i], script);
+
+  int failures = 0;
+  for (std::size_t i = 0; i < roms.size(); ++i)
+    if (!results[i].error.empty()) {
+      std::cout << "ERROR " << roms[i] << " " << results[i].error
+                << std::endl;
+      ++failures;
+    }
+
+  if (update) {
+    std::ofstream golden(argv[3]), baseline(argv[4]);
+    for (std::size_t i = 0; i < roms.size(); ++i) {
+      for (auto const &c : results[i].checksums)
+        golden << roms[i] << " " << c.frame << " " << std::hex << c.graphics
+               << " " << c.memory << std::dec << " " << c.trapped
+               << std::endl;
+      if (results[i].error.empty() && !results[i].trapped)
+        baseline << roms[i] << " " << results[i].instructions_per_second
+                 << std::endl;
+    }
+    std::cout << "Updated " << roms.size() - failures << " roms" << std::endl;
+    return failures == 0 ? 0 : 1;
+  }
+
+  /** Comparing against golden checksums and baseline throughput **/
+  using Key = std::pair<std::string, std::size_t>;
+  std::map<Key, emulators::RegressionChecksum> golden;
+  std::map<std::string, double> baseline;
+  std::string rom;
+  emulators::RegressionChecksum g;
+  double ips;
+  for (std::ifstream in(argv[3]); in >> rom >> g.frame >> std::hex >>
+                                  g.graphics >> g.memory >> std::dec >>
+                                  g.trapped;)
+    golden[{rom, g.frame}] = g;
+  for (std::ifstream in(argv[4]); in >> rom >> ips;) baseline[rom] = ips;
+
+  std::set<Key> seen;
+  for (std::size_t i = 0; i < roms.size(); ++i) {
+    Result const &r = results[i];
+    if (!r.error.empty()) {
+      for (auto const &entry : golden)
+        if (entry.first.first == roms[i]) seen.insert(entry.first);
+      continue;
+    }
+
+    for (auto const &c : r.checksums) {
+      seen.insert({roms[i], c.frame});
+      auto entry = golden.find({roms[i], c.frame});
+      if (entry == golden.end()) {
+        std::cout << "NEW   " << roms[i] << " frame " << c.frame << std::endl;
+        ++failures;
+        continue;
+      }
+
+      emulators::RegressionChecksum const &e = entry->second;
+      if (c.trapped && !e.trapped) {
+        std::cout << "TRAP  " << roms[i] << " frame " << c.frame << std::endl;
+        ++failures;
+      } else if (e.graphics != c.graphics || e.memory != c.memory ||
+                 e.trapped != c.trapped) {
+        std::cout << "DIFF  " << roms[i] << " frame " << c.frame
+                  << (e.graphics != c.graphics ? " graphics" : "")
+                  << (e.memory != c.memory ? " memory" : "")
+                  << (e.trapped != c.trapped ? " trap" : "") << std::endl;
+        ++failures;
+      }
+    }
+
+    auto b = baseline.find(roms[i]);
+    if (r.trapped || b == baseline.end()) continue;
+    double minimum = b->second * (1 - THROUGHPUT_TOLERANCE);
+    for (int retry = 0;
+         retry < THROUGHPUT_RETRIES && r.instructions_per_second < minimum;
+         ++retry) {
+      results[i].instructions_per_second =
+          std::max(r.instructions_per_second,
+                   emulators::MeasureThroughput(pool, images[i], script));
+    }
+    if (r.instructions_per_second < minimum) {
+      std::cout << "SLOW  " << roms[i] << " " << r.instructions_per_second
+                << " instructions/s, baseline " << b->second << std::endl;
+      ++failures;
+    }
+  }
+
+  for (auto const &entry : golden)
+    if (!seen.count(entry.first)) {
+      std::cout << "GONE  " << entry.first.first << " frame "
+                << entry.first.second << std::endl;
+      ++failures;
+    }
+
+  std::cout << roms.size() << " roms, " << failures << " failures"
+            << std::endl;
+  return failures == 0 ? 0 : 1;
+}
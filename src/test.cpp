@@ -28,17 +28,16 @@
 #include "chip8.hpp"
 using Emulator = emulators::Chip8<>;
 
-Emulator *emulator;
+Emulator emulator;
 
 int main(int argc, char **argv) {
   /**  Creating emulator and loading rom **/
-  emulator = new Emulator;
   if (argc != 3) {
     std::cerr << "usage: " << argv[0] << " [rom] [test]" << std::endl;
     return -1;
   }
 
-  if (int err = emulator->LoadProgram(argv[1]) != 0) {
+  if (int err = emulator.LoadProgram(argv[1]) != 0) {
     std::cerr << "loading " << argv[1] << " returned error code " << err
               << std::endl;
     return -1;
@@ -54,13 +53,12 @@ int main(int argc, char **argv) {
     in >> index >> sp;
     std::cout << std::setw(8) << line << ": ";
     if (!in.good()) break;
-    emulator->DecrementTimers();
-    emulator->TestEvaluateInstruction(pc, opcode, overwrite, v, index, sp);
+    emulator.DecrementTimers();
+    emulator.TestEvaluateInstruction(pc, opcode, overwrite, v, index, sp);
     ++line;
   }
 
   std::cout << "Test finished" << std::endl;
-  delete emulator;
 
   return 0;
 }